@@ -5,25 +5,74 @@
 #include <vector>
 #include <map>
 #include <unordered_map>
+#include <istream>
+#include <ostream>
 
 class SuffixArray {
 public:
+    // Longest prefix of query[queryPos..] occurring in the text,
+    // together with its suffix array interval SA[begin, end)
+    struct ExactMatch {
+        size_t queryPos;
+        size_t length;
+        size_t begin;
+        size_t end;
+    };
+
+    // lcp-interval SA[begin, end): the suffixes in it share exactly their first lcp characters
+    struct LCPInterval {
+        size_t lcp;
+        size_t begin;
+        size_t end;
+    };
+
     explicit SuffixArray(const std::string& input_string);
     explicit SuffixArray(const std::vector<size_t>& S0);
     std::vector<size_t> search(const std::string &pattern) const;
     std::vector<size_t> getSA();
 
+    std::vector<ExactMatch> matchingStatistics(const std::string &query) const;
+    std::vector<ExactMatch> superMaximalExactMatches(const std::string &query, const size_t minLength = 1) const;
+    std::vector<size_t> getOccurrences(const ExactMatch &match) const;
+
+    void buildQGramTable(const size_t q);
+    size_t count(const std::string &pattern) const;
+
+    void buildChildTable();
+    std::vector<LCPInterval> findRepeats(const size_t minLength) const;
+    std::vector<size_t> getOccurrences(const LCPInterval &interval) const;
+
+    void save(std::ostream &out) const;
+    static SuffixArray load(std::istream &in);
+
 private:
+    SuffixArray() = default;
+
     std::vector<size_t> S;
     std::vector<size_t> SA;
     std::vector<size_t> LCP;
+    std::vector<size_t> ISA;
 
+    // q-gram jump table, qGramLength == 0 when it was not built.
+    // qGramTable[c] is the number of suffixes of length >= q whose q-gram code is smaller than c
+    size_t qGramLength = 0;
+    std::unordered_map<size_t, size_t> qGramAlphabet;
+    std::vector<size_t> qGramTable;
+
+    // enhanced suffix array child table (Abouelhoda et al.) in its single array form, empty when it was not built
+    std::vector<size_t> childTable;
+
+    static std::vector<size_t> convertString(const std::string &str);
+    static std::vector<size_t> inverseOf(const std::vector<size_t> &S1);
     void constructS(const std::string &str);
     std::map<size_t, size_t> calcCharCounts() const;
     std::vector<size_t> initBuckets(const std::map<size_t, size_t> &charCounts, std::unordered_map<size_t, size_t> &charToBucket) const;
     std::vector<bool> constructTTypeArray() const;
     std::vector<size_t> constructSamplePointerArray(const std::vector<bool> &typeTArray) const;
     std::vector<size_t> initTails(const std::vector<size_t> &buckets) const;
+    // only the induction kernel selected by SUFFIX_ARRAY_PREFETCH_INDUCTION is defined
+    std::vector<size_t> constructPackedTypes(const std::vector<bool> &typeTArray, std::unordered_map<size_t, size_t> &charToBucket) const;
+    void induceSuffixes(const std::vector<size_t> &buckets, const std::vector<size_t> &packedTypes);
     void induceSuffixes(
         const std::vector<size_t> &buckets,
         const std::vector<bool> &typeTArray,
@@ -42,7 +91,8 @@ private:
         std::map<size_t, size_t> &charCounts,
         const std::vector<size_t> &buckets, 
         std::unordered_map<size_t, size_t> &charToBucket,
-        const std::vector<bool> &typeTArray
+        const std::vector<bool> &typeTArray,
+        const std::vector<size_t> &packedTypes
     );
 
     void inducedSort(
@@ -50,7 +100,8 @@ private:
         std::map<size_t, size_t> &charCounts,
         const std::vector<size_t> &buckets, 
         std::unordered_map<size_t, size_t> &charToBucket,
-        const std::vector<bool> &typeTArray
+        const std::vector<bool> &typeTArray,
+        const std::vector<size_t> &packedTypes
     ); 
 
     size_t getLMSSubstrLen(const size_t SPAIndex, const std::vector<size_t> &samplePointerArray) const;
@@ -61,7 +112,6 @@ private:
         bool &areAllLettersUnique
     ) const;
 
-    std::vector<size_t> findAllOccurances(const size_t suffixArrayMatchIndex, const size_t patternLength) const;
     size_t LCPRec(const size_t i, const size_t j);
     void constructLCPArray();
     size_t getLCP(const size_t index1, const size_t index2) const;
@@ -71,6 +121,21 @@ private:
         const size_t patternLength, 
         const size_t stringIndex) const;
     std::vector<size_t> searchPrivate(const std::vector<size_t> &pattern) const;
+    bool findInterval(const std::vector<size_t> &pattern, size_t &low, size_t &high) const;
+    bool searchInterval(const std::vector<size_t> &pattern, size_t &low, size_t &high) const;
+    bool getQGramInterval(const std::vector<size_t> &pattern, size_t &low, size_t &end) const;
+
+    void validate();
+
+    size_t getFirstLIndex(const size_t i, const size_t j) const;
+    size_t getNextLIndex(const size_t i) const;
+    bool getChildInterval(const size_t i, const size_t j, const size_t depth, const size_t c, size_t &low, size_t &high) const;
+    bool searchChildTable(const std::vector<size_t> &pattern, size_t &low, size_t &high, size_t depth) const;
+
+    size_t findNextSmallerLCP(const size_t i, const size_t j, const size_t from, const size_t bound) const;
+    size_t findPrevSmallerLCP(const size_t i, const size_t j, const size_t to, const size_t bound) const;
+    void expandInterval(const size_t suffixArrayIndex, const size_t length, size_t &low, size_t &high) const;
+    bool narrowInterval(const size_t depth, const size_t c, size_t &low, size_t &high) const;
 };
 
 #endif // SUFFIXARRAY_H
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "SuffixArray.h"
+
+// Long-running query server. The index is built or loaded once and then answers
+// one pattern per line, either on stdin/stdout or on a local Unix domain socket.
+//
+// Text results are one line per pattern: the number of occurrences followed by the sorted positions.
+// Binary results are the count followed by the positions, each a native-endian uint64.
+// With --count only the number of occurrences is returned.
+// A pattern line longer than MAX_LINE_LENGTH disconnects its socket client, on stdin it stops the server.
+
+struct Options {
+    std::string textFile;
+    std::string indexFile;
+    std::string saveFile;
+    std::string socketPath;
+    size_t qGramLength = 0;
+    bool childTable = false;
+    bool binary = false;
+    bool countOnly = false;
+};
+
+struct Request {
+    size_t client;
+    std::string pattern;
+};
+
+struct Client {
+    int fd;
+    std::string input;
+    std::string output;
+    bool closed = false;
+    // input before this offset is known to contain no newline
+    size_t scanned = 0;
+};
+
+const size_t READ_CHUNK = 1 << 16;
+// a client is not read from while this much of its output is still unsent
+const size_t MAX_PENDING_OUTPUT = 1 << 22;
+// longest accepted pattern line, so a client that never sends a newline can not grow its input without bound
+const size_t MAX_LINE_LENGTH = 1 << 20;
+
+// path of the listening socket, removed when the server is stopped by a signal
+char boundSocketPath[sizeof(sockaddr_un::sun_path)];
+
+void printUsage() {
+    std::cerr << "Usage: SuffixArrayServer (--text FILE | --index FILE) [--save FILE] [--qgram Q] [--child-table]\n"
+                 "                         [--socket PATH] [--binary] [--count]\n";
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--text" && hasValue)
+            options.textFile = argv[++i];
+        else if (arg == "--index" && hasValue)
+            options.indexFile = argv[++i];
+        else if (arg == "--save" && hasValue)
+            options.saveFile = argv[++i];
+        else if (arg == "--socket" && hasValue)
+            options.socketPath = argv[++i];
+        else if (arg == "--qgram" && hasValue)
+            options.qGramLength = std::stoul(argv[++i]);
+        else if (arg == "--child-table")
+            options.childTable = true;
+        else if (arg == "--binary")
+            options.binary = true;
+        else if (arg == "--count")
+            options.countOnly = true;
+        else
+            return false;
+    }
+    return options.textFile.empty() != options.indexFile.empty();
+}
+
+// Same format as the time tests, lines are concatenated into one string
+std::string readString(const std::string &filename) {
+    std::ifstream file(filename);
+    std::string line;
+    std::string string;
+    while (getline(file, line)) {
+        string += line;
+    }
+    if (file.bad())
+        throw std::runtime_error("can not read text " + filename);
+    return string;
+}
+
+SuffixArray buildOrLoad(const Options &options) {
+    if (!options.indexFile.empty()) {
+        std::ifstream file(options.indexFile, std::ios::binary);
+        if (!file)
+            throw std::runtime_error("can not open index " + options.indexFile);
+        return SuffixArray::load(file);
+    }
+
+    std::ifstream file(options.textFile);
+    if (!file)
+        throw std::runtime_error("can not open text " + options.textFile);
+    std::string text = readString(options.textFile);
+    if (text.empty())
+        throw std::runtime_error("text " + options.textFile + " is empty");
+    return SuffixArray(text);
+}
+
+SuffixArray loadIndex(const Options &options) {
+    SuffixArray suffixArray = buildOrLoad(options);
+    // tables can also be added on top of a loaded index
+    if (options.qGramLength != 0)
+        suffixArray.buildQGramTable(options.qGramLength);
+    if (options.childTable)
+        suffixArray.buildChildTable();
+
+    if (!options.saveFile.empty()) {
+        std::ofstream out(options.saveFile, std::ios::binary);
+        suffixArray.save(out);
+        if (!out)
+            throw std::runtime_error("can not write index " + options.saveFile);
+    }
+    return suffixArray;
+}
+
+void appendValue(std::string &output, uint64_t value) {
+    char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    output.append(bytes, sizeof(value));
+}
+
+std::string formatResult(const std::vector<size_t> &positions, size_t count, const Options &options) {
+    std::string output;
+    if (options.binary) {
+        appendValue(output, count);
+        for (size_t position : positions)
+            appendValue(output, position);
+    } else {
+        output = std::to_string(count);
+        for (size_t position : positions)
+            output += " " + std::to_string(position);
+        output += '\n';
+    }
+    return output;
+}
+
+// Answers a whole batch in one lookup pass. Requests are visited in pattern order,
+// so equal patterns are looked up once and neighbouring lookups touch nearby parts of SA
+std::vector<std::string> processBatch(const SuffixArray &suffixArray, const std::vector<Request> &batch, const Options &options) {
+    std::vector<size_t> order(batch.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&batch](size_t a, size_t b) {
+        return batch[a].pattern < batch[b].pattern;
+    });
+
+    std::vector<std::string> results(batch.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        const std::string &pattern = batch[order[i]].pattern;
+        if (i > 0 && pattern == batch[order[i - 1]].pattern) {
+            results[order[i]] = results[order[i - 1]];
+            continue;
+        }
+
+        if (options.countOnly) {
+            results[order[i]] = formatResult({}, suffixArray.count(pattern), options);
+        } else {
+            std::vector<size_t> positions = suffixArray.search(pattern);
+            std::sort(positions.begin(), positions.end());
+            results[order[i]] = formatResult(positions, positions.size(), options);
+        }
+    }
+    return results;
+}
+
+// Moves every complete line of input into the batch, a trailing carriage return is dropped.
+// Only the data received since the last call is scanned for newlines.
+// Returns false when a line is longer than MAX_LINE_LENGTH
+bool extractRequests(size_t clientIndex, Client &client, std::vector<Request> &batch) {
+    std::string &input = client.input;
+    size_t start = 0, newline;
+    while ((newline = input.find('\n', std::max(start, client.scanned))) != std::string::npos) {
+        if (newline - start > MAX_LINE_LENGTH)
+            return false;
+        size_t end = newline;
+        if (end > start && input[end - 1] == '\r')
+            end--;
+        batch.push_back({clientIndex, input.substr(start, end - start)});
+        start = newline + 1;
+    }
+    input.erase(0, start);
+    client.scanned = input.size();
+    return input.size() <= MAX_LINE_LENGTH;
+}
+
+// Writes as much of output as the descriptor accepts and drops the written part
+bool flushOutput(int fd, std::string &output) {
+    while (!output.empty()) {
+        ssize_t written = write(fd, output.data(), output.size());
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        output.erase(0, static_cast<size_t>(written));
+    }
+    return true;
+}
+
+// Requests already waiting in the pipe are read together and answered as one batch,
+// so a client that pipelines many patterns is not served one line at a time
+int servePipe(const SuffixArray &suffixArray, const Options &options) {
+    Client client{STDIN_FILENO, "", ""};
+    std::vector<char> buffer(READ_CHUNK);
+
+    while (true) {
+        ssize_t received = read(STDIN_FILENO, buffer.data(), buffer.size());
+        if (received < 0 && errno == EINTR)
+            continue;
+        if (received < 0)
+            return 1;
+
+        if (received == 0) {
+            // the last pattern does not need a newline
+            if (!client.input.empty())
+                client.input += '\n';
+            client.closed = true;
+        } else {
+            client.input.append(buffer.data(), static_cast<size_t>(received));
+        }
+
+        std::vector<Request> batch;
+        bool tooLong = !extractRequests(0, client, batch);
+        for (std::string &result : processBatch(suffixArray, batch, options))
+            client.output += result;
+        if (!flushOutput(STDOUT_FILENO, client.output))
+            return 1;
+
+        if (tooLong) {
+            std::cerr << "Pattern line longer than " << MAX_LINE_LENGTH << " bytes" << std::endl;
+            return 1;
+        }
+        if (client.closed)
+            return 0;
+    }
+}
+
+int openSocket(const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    // only a stale socket is replaced, any other file at path is left alone
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            errno = EEXIST;
+            return -1;
+        }
+        unlink(path.c_str());
+    } else if (errno != ENOENT) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+extern "C" void removeSocketAndExit(int signal) {
+    unlink(boundSocketPath);
+    _exit(128 + signal);
+}
+
+// Single-threaded event loop. Every round gathers the complete lines of all readable clients
+// into one batch, so concurrent requests share a single lookup pass
+int serveSocket(const SuffixArray &suffixArray, const Options &options) {
+    int listenFd = openSocket(options.socketPath);
+    if (listenFd < 0) {
+        std::cerr << "Can not listen on " << options.socketPath << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    std::strncpy(boundSocketPath, options.socketPath.c_str(), sizeof(boundSocketPath) - 1);
+    std::signal(SIGINT, removeSocketAndExit);
+    std::signal(SIGTERM, removeSocketAndExit);
+    std::cerr << "Listening on " << options.socketPath << std::endl;
+
+    std::vector<Client> clients;
+    std::vector<char> buffer(READ_CHUNK);
+
+    while (true) {
+        std::vector<pollfd> fds = {{listenFd, POLLIN, 0}};
+        for (const Client &client : clients) {
+            // backpressure: a client that does not read its results is not read from either
+            short events = (client.closed || client.output.size() >= MAX_PENDING_OUTPUT) ? 0 : POLLIN;
+            if (!client.output.empty())
+                events |= POLLOUT;
+            fds.push_back({client.fd, events, 0});
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            unlink(boundSocketPath);
+            return 1;
+        }
+
+        std::vector<Request> batch;
+        for (size_t i = 0; i < clients.size(); i++) {
+            Client &client = clients[i];
+            short events = fds[i + 1].revents;
+            if (events & POLLOUT && !flushOutput(client.fd, client.output))
+                client.closed = true;
+            if (!(events & (POLLIN | POLLHUP | POLLERR)) || client.closed || client.output.size() >= MAX_PENDING_OUTPUT)
+                continue;
+
+            ssize_t received = read(client.fd, buffer.data(), buffer.size());
+            if (received < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            if (received <= 0) {
+                if (!client.input.empty())
+                    client.input += '\n';
+                client.closed = true;
+            } else {
+                client.input.append(buffer.data(), static_cast<size_t>(received));
+            }
+            if (!extractRequests(i, client, batch)) {
+                client.input.clear();
+                client.closed = true;
+            }
+        }
+
+        std::vector<std::string> results = processBatch(suffixArray, batch, options);
+        for (size_t i = 0; i < batch.size(); i++)
+            clients[batch[i].client].output += results[i];
+
+        // closed clients still get the answers to the requests they sent before hanging up
+        for (Client &client : clients) {
+            if (!flushOutput(client.fd, client.output))
+                client.output.clear();
+            if (client.closed && client.output.empty()) {
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client &client) {
+            return client.fd < 0;
+        }), clients.end());
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(listenFd, nullptr, nullptr)) >= 0) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                clients.push_back({fd, "", ""});
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage();
+            return 2;
+        }
+    } catch (const std::exception &) {
+        printUsage();
+        return 2;
+    }
+
+    // a client hanging up must not take the server down
+    std::signal(SIGPIPE, SIG_IGN);
+
+    try {
+        SuffixArray suffixArray = loadIndex(options);
+        if (options.socketPath.empty())
+            return servePipe(suffixArray, options);
+        return serveSocket(suffixArray, options);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
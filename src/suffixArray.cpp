@@ -2,6 +2,25 @@
 #include <climits>
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
+
+// upper bound on the number of q-gram table entries, 2^25 entries take 256 MiB
+const size_t MAX_QGRAM_TABLE_SIZE = size_t(1) << 25;
+
+#ifdef SUFFIX_ARRAY_PREFETCH_INDUCTION
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH_READ(address) __builtin_prefetch((address), 0)
+#define PREFETCH_WRITE(address) __builtin_prefetch((address), 1)
+#else
+#define PREFETCH_READ(address) ((void)0)
+#define PREFETCH_WRITE(address) ((void)0)
+#endif
+
+// how many SA entries ahead of the induction scans the prefetches are issued
+#ifndef INDUCTION_PREFETCH_DISTANCE
+#define INDUCTION_PREFETCH_DISTANCE 32
+#endif
+#endif
 
     
 // Constructor for the SuffixArray class. Initializes and builds the suffix array for the given input string.
@@ -19,21 +38,27 @@ SuffixArray::SuffixArray(const std::string& input_string) {
     std::map<size_t, size_t> charCounts = calcCharCounts();
     std::unordered_map<size_t, size_t> charToBucket;
     std::vector<size_t> buckets = initBuckets(charCounts, charToBucket);
+#ifdef SUFFIX_ARRAY_PREFETCH_INDUCTION
+    // both induced sorts of this level share the packed bucket and type array
+    const std::vector<size_t> packedTypes = constructPackedTypes(typeTArray, charToBucket);
+#else
+    const std::vector<size_t> packedTypes;
+#endif
 
 
     // Perform induced sorting on LMS (Left-Most S-type) substrings. .
-    inducedSort(samplePointerArray, charCounts, buckets, charToBucket, typeTArray);
+    inducedSort(samplePointerArray, charCounts, buckets, charToBucket, typeTArray, packedTypes);
 
     // Check if all the characters in the reduced string S1 are unique.
     // If all characters in S1 are unique, directly compute the suffix array SA1.
     // Otherwise, recursively construct the suffix array for the reduced string S1.
-    bool areAllLettersUnique;
+    bool areAllLettersUnique = true;
     std::vector<size_t> S1 = constructS1AndCheckAllUniqueLetters(samplePointerArray, buckets, areAllLettersUnique);
     if (areAllLettersUnique){ 
-        inducedSort(S1, samplePointerArray, charCounts, buckets, charToBucket, typeTArray);
+        inducedSort(inverseOf(S1), samplePointerArray, charCounts, buckets, charToBucket, typeTArray, packedTypes);
     } else {
         SuffixArray suffixArray(S1);
-        inducedSort(suffixArray.getSA(), samplePointerArray, charCounts, buckets, charToBucket, typeTArray);
+        inducedSort(suffixArray.getSA(), samplePointerArray, charCounts, buckets, charToBucket, typeTArray, packedTypes);
     }
 
     // Construct the enchanced LCP (Longest Common Prefix) array
@@ -51,46 +76,57 @@ SuffixArray::SuffixArray(const std::vector<size_t>& S0) {
     std::map<size_t, size_t> charCounts = calcCharCounts();
     std::unordered_map<size_t, size_t> charToBucket;
     std::vector<size_t> buckets = initBuckets(charCounts, charToBucket);
-    inducedSort(samplePointerArray, charCounts, buckets, charToBucket, typeTArray);
+#ifdef SUFFIX_ARRAY_PREFETCH_INDUCTION
+    const std::vector<size_t> packedTypes = constructPackedTypes(typeTArray, charToBucket);
+#else
+    const std::vector<size_t> packedTypes;
+#endif
+    inducedSort(samplePointerArray, charCounts, buckets, charToBucket, typeTArray, packedTypes);
     bool areAllLettersUnique = true;
 
     std::vector<size_t> S1 = constructS1AndCheckAllUniqueLetters(samplePointerArray, buckets, areAllLettersUnique);
     if (areAllLettersUnique){ 
 
-        inducedSort(S1, samplePointerArray, charCounts, buckets, charToBucket, typeTArray);
+        inducedSort(inverseOf(S1), samplePointerArray, charCounts, buckets, charToBucket, typeTArray, packedTypes);
 
     } else {
         SuffixArray suffixArray(S1);
-        inducedSort(suffixArray.SA, samplePointerArray, charCounts, buckets, charToBucket, typeTArray);
+        inducedSort(suffixArray.SA, samplePointerArray, charCounts, buckets, charToBucket, typeTArray, packedTypes);
     }
 }
 
 std::vector<size_t> SuffixArray::getSA(){return SA;}
 
+// When all letters of S1 are unique, its suffix array is simply the inverse permutation of S1
+std::vector<size_t> SuffixArray::inverseOf(const std::vector<size_t> &S1) {
+    std::vector<size_t> SA1(S1.size());
+    for (size_t i = 0; i < S1.size(); i++)
+        SA1[S1[i]] = i;
+    return SA1;
+}
+
 std::vector<size_t> SuffixArray::search(const std::string &pattern) const{
     // Prepare the pattern to be searched by turning it into a vector of ints
     // the same way the string was processed
     if (pattern.empty())
         return {};
 
-    std::vector<size_t> patternInt;
-    patternInt.reserve(pattern.length());
-    std::transform(pattern.begin(), pattern.end(), std::back_inserter(patternInt), [](char c) {
-        return static_cast<size_t>(c - '\0');
-    });
-
     // search logic is within the private part of the class
-    return searchPrivate(patternInt);
+    return searchPrivate(convertString(pattern));
 }
 
-// Convert string to vector of ints and append sentinel
-void SuffixArray::constructS(const std::string &str) {  
-    S.reserve(str.length() + 1);
-
-    std::transform(str.begin(), str.end(), std::back_inserter(S), [](char c) {
+std::vector<size_t> SuffixArray::convertString(const std::string &str) {
+    std::vector<size_t> result;
+    result.reserve(str.length() + 1);
+    std::transform(str.begin(), str.end(), std::back_inserter(result), [](char c) {
         return static_cast<size_t>(c - '\0');
     });
+    return result;
+}
 
+// Convert string to vector of ints and append sentinel
+void SuffixArray::constructS(const std::string &str) {  
+    S = convertString(str);
     S.push_back(0);
 }
 
@@ -162,6 +198,62 @@ std::vector<size_t> SuffixArray::initTails(const std::vector<size_t> &buckets) c
     return tails;
 }
 
+#ifdef SUFFIX_ARRAY_PREFETCH_INDUCTION
+// packedTypes[i] = bucket of S[i] << 1 | type of S[i], built once per recursion level
+std::vector<size_t> SuffixArray::constructPackedTypes(const std::vector<bool> &typeTArray, std::unordered_map<size_t, size_t> &charToBucket) const{
+    std::vector<size_t> packedTypes(S.size());
+    for (size_t i = 0; i < S.size(); i++)
+        packedTypes[i] = (charToBucket[S[i]] << 1) | static_cast<size_t>(typeTArray[i]);
+    return packedTypes;
+}
+
+// Prefetching induction kernel. Each step of the scans reads the bucket and type of SA[i] - 1 at random,
+// which makes the plain loop memory latency bound once the input does not fit in cache.
+// Bucket index and type are packed into one word per position by constructPackedTypes, so a step needs a single random read.
+// The scans run a two stage pipeline: the packed word is prefetched 2 * distance entries ahead
+// and the bucket slot it will be written to is prefetched distance entries ahead.
+// SA entries further ahead may still change before the scan reaches them, which only wastes a prefetch
+void SuffixArray::induceSuffixes(const std::vector<size_t> &buckets, const std::vector<size_t> &packed) {
+    const size_t distance = INDUCTION_PREFETCH_DISTANCE;
+    const size_t n = S.size();
+    std::vector<size_t> heads(buckets);
+    std::vector<size_t> tails = initTails(buckets);
+
+    for (size_t i = 0; i < n; i++) {
+        if (i + 2 * distance < n && SA[i + 2 * distance] != 0)
+            PREFETCH_READ(&packed[SA[i + 2 * distance] - 1]);
+        if (i + distance < n && SA[i + distance] != 0) {
+            size_t ahead = packed[SA[i + distance] - 1];
+            if ((ahead & 1) == 0)
+                PREFETCH_WRITE(&SA[heads[ahead >> 1]]);
+        }
+
+        if (SA[i] == 0) continue;
+        size_t previous = packed[SA[i] - 1];
+        if ((previous & 1) == 0) // if previous suffix is L type
+            SA[heads[previous >> 1]++] = SA[i] - 1;
+    }
+
+    size_t i = n - 1;
+    while (true){
+        if (i >= 2 * distance && SA[i - 2 * distance] != 0)
+            PREFETCH_READ(&packed[SA[i - 2 * distance] - 1]);
+        if (i >= distance && SA[i - distance] != 0) {
+            size_t ahead = packed[SA[i - distance] - 1];
+            if ((ahead & 1) == 1)
+                PREFETCH_WRITE(&SA[tails[ahead >> 1]]);
+        }
+
+        if (SA[i] != 0) {
+            size_t previous = packed[SA[i] - 1];
+            if ((previous & 1) == 1) // if previous suffix is S type
+                SA[tails[previous >> 1]--] = SA[i] - 1;
+        }
+        if (i == 0) break;
+        i--;
+    }
+}
+#else
 void SuffixArray::induceSuffixes(
     const std::vector<size_t> &buckets,
     const std::vector<bool> &typeTArray,
@@ -185,6 +277,7 @@ void SuffixArray::induceSuffixes(
         i--;
     }  
 }
+#endif
 
 void SuffixArray::inducedSortCommon(
     std::map<size_t, size_t> &charCounts,
@@ -207,7 +300,9 @@ void SuffixArray::inducedSort(
     std::map<size_t, size_t> &charCounts,
     const std::vector<size_t> &buckets, 
     std::unordered_map<size_t, size_t> &charToBucket,
-    const std::vector<bool> &typeTArray) 
+    // the plain kernel reads typeTArray, the prefetching one packedTypes
+    [[maybe_unused]] const std::vector<bool> &typeTArray,
+    [[maybe_unused]] const std::vector<size_t> &packedTypes) 
 {
     inducedSortCommon(charCounts, buckets, charToBucket);
     std::vector<size_t> tails = initTails(buckets);
@@ -219,7 +314,11 @@ void SuffixArray::inducedSort(
         if (i == 0) break;
         i--;
     }
+#ifdef SUFFIX_ARRAY_PREFETCH_INDUCTION
+    induceSuffixes(buckets, packedTypes);
+#else
     induceSuffixes(buckets, typeTArray, charToBucket);
+#endif
 }
 
 void SuffixArray::inducedSort(
@@ -227,7 +326,9 @@ void SuffixArray::inducedSort(
     std::map<size_t, size_t> &charCounts,
     const std::vector<size_t> &buckets, 
     std::unordered_map<size_t, size_t> &charToBucket,
-    const std::vector<bool> &typeTArray) 
+    // the plain kernel reads typeTArray, the prefetching one packedTypes
+    [[maybe_unused]] const std::vector<bool> &typeTArray,
+    [[maybe_unused]] const std::vector<size_t> &packedTypes) 
 {
 
     inducedSortCommon(charCounts, buckets, charToBucket);
@@ -239,7 +340,11 @@ void SuffixArray::inducedSort(
         SA[tails[charToBucket[S[indexToLoad]]]--] = indexToLoad;
     }
 
+#ifdef SUFFIX_ARRAY_PREFETCH_INDUCTION
+    induceSuffixes(buckets, packedTypes);
+#else
     induceSuffixes(buckets, typeTArray, charToBucket);
+#endif
 }
 
 size_t SuffixArray::getLMSSubstrLen(size_t SPAIndex, const std::vector<size_t> &samplePointerArray) const{
@@ -314,7 +419,10 @@ size_t SuffixArray::LCPRec(const size_t i, const size_t j){
 }
 
 void SuffixArray::constructLCPArray() {
-    std::vector<size_t> rank(S.size(), 0);
+    // the rank array is kept as the inverse suffix array,
+    // matching statistics use it to drop the first character of a match
+    std::vector<size_t> &rank = ISA;
+    rank.assign(S.size(), 0);
     LCP.resize(S.size() * 2 - 1, 0);
 
     // Building the rank array
@@ -335,7 +443,9 @@ void SuffixArray::constructLCPArray() {
         LCP[rank[i] + 1] = k; // LCP between the current and next suffix in the suffix array
     }
     LCP[0] = 0;
-    LCPRec(0, S.size() - 1);
+    // an empty text has only the sentinel suffix and no interval LCPs
+    if (S.size() > 1)
+        LCPRec(0, S.size() - 1);
 }
 
 size_t SuffixArray::getLCP(const size_t index1, const size_t index2) const{
@@ -354,41 +464,55 @@ size_t SuffixArray::countMatches(const std::vector<size_t> &pattern, size_t star
     return matches;
 }
 
-std::vector<size_t> SuffixArray::findAllOccurances(const size_t suffixArrayMatchIndex, const size_t patternLength) const{
-    std::vector<size_t> matches = {SA[suffixArrayMatchIndex]};
+std::vector<size_t> SuffixArray::searchPrivate(const std::vector<size_t> &pattern) const{
+    size_t low, high;
+    if (!findInterval(pattern, low, high))
+        return {};
+    return std::vector<size_t>(SA.begin() + low, SA.begin() + high + 1);
+}
 
-    // check to the left of intial match
-    size_t suffixArrayIndex = suffixArrayMatchIndex;
-    while (true) {
-        if (suffixArrayIndex == 0)
-            break;
-        if (LCP[suffixArrayIndex] >= patternLength)
-            matches.push_back(SA[suffixArrayIndex - 1]);
-        else
-            break;
-        suffixArrayIndex--;
+// Finds the interval SA[low..high] of all suffixes starting with pattern
+bool SuffixArray::findInterval(const std::vector<size_t> &pattern, size_t &low, size_t &high) const{
+    // the sentinel is not part of the text and can not be matched,
+    // comparing past it would also read beyond the end of S
+    if (std::find(pattern.begin(), pattern.end(), 0) != pattern.end())
+        return false;
+
+    // jump straight to the interval of the first q characters when the table is built,
+    // patterns of at most q characters are answered by the table alone
+    if (qGramLength != 0) {
+        size_t end;
+        if (!getQGramInterval(pattern, low, end))
+            return false;
+        high = end - 1;
+        if (pattern.size() <= qGramLength)
+            return true;
+        if (!childTable.empty())
+            return searchChildTable(pattern, low, high, qGramLength);
+        return searchInterval(pattern, low, high);
     }
 
-    // check to the left of intial match
-    for (size_t suffixArrayIndex = suffixArrayMatchIndex + 1; suffixArrayIndex < S.size(); suffixArrayIndex++) {
-        if (LCP[suffixArrayIndex] >= patternLength)
-            matches.push_back(SA[suffixArrayIndex]);
-        else
-            break;
+    // top-down traversal of the virtual suffix tree
+    if (!childTable.empty()) {
+        low = 0;
+        high = SA.size() - 1;
+        return searchChildTable(pattern, low, high, 0);
     }
-    return matches;
-}
 
-std::vector<size_t> SuffixArray::searchPrivate(const std::vector<size_t> &pattern) const{
-    size_t low = 0, high = SA.size() - 1;
+    low = 0;
+    high = SA.size() - 1;
     size_t lowMatches = countMatches(pattern, 0, pattern.size(), SA[low]);
     size_t highMatches = countMatches(pattern, 0, pattern.size(), SA[high]);
 
-    if (highMatches == pattern.size())
-        return findAllOccurances(high, pattern.size());
+    if (highMatches == pattern.size()) {
+        expandInterval(high, pattern.size(), low, high);
+        return true;
+    }
 
-    if (lowMatches == pattern.size())
-        return findAllOccurances(low, pattern.size());
+    if (lowMatches == pattern.size()) {
+        expandInterval(low, pattern.size(), low, high);
+        return true;
+    }
 
     size_t mid;
     size_t lcpLow, lcpHigh;
@@ -422,8 +546,10 @@ std::vector<size_t> SuffixArray::searchPrivate(const std::vector<size_t> &patter
             maxMatches = std::max(lowMatches, highMatches);
             maxMatches = countMatches(pattern, maxMatches, pattern.size(), SA[mid]);
 
-            if (maxMatches == pattern.size()) // if exact match occurs
-                return findAllOccurances(mid, pattern.size());
+            if (maxMatches == pattern.size()) { // if exact match occurs
+                expandInterval(mid, pattern.size(), low, high);
+                return true;
+            }
             else if (S[SA[mid] + maxMatches] < pattern[maxMatches]) { // unmatched letter of pattern is bigger
                 low = mid;
                 lowMatches = maxMatches;
@@ -433,5 +559,490 @@ std::vector<size_t> SuffixArray::searchPrivate(const std::vector<size_t> &patter
             }
         }
     }
-    return {};
-}
\ No newline at end of file
+    return false;
+}
+
+// The interval LCP half of LCP forms a segment tree over LCP[1..n-1]:
+// node (i, j) covers LCP[i + 1..j] and splits at (i + j) / 2, exactly as in LCPRec.
+// Returns the smallest index p > from covered by node (i, j) with LCP[p] < bound, or 0 if there is none
+size_t SuffixArray::findNextSmallerLCP(const size_t i, const size_t j, const size_t from, const size_t bound) const{
+    if (j <= from || getLCP(i, j) >= bound)
+        return 0;
+    if (j - i == 1)
+        return j;
+    size_t mid = (i + j) / 2;
+    size_t res = findNextSmallerLCP(i, mid, from, bound);
+    if (res != 0)
+        return res;
+    return findNextSmallerLCP(mid, j, from, bound);
+}
+
+// Returns the largest index p <= to covered by node (i, j) with LCP[p] < bound, or 0 if there is none
+size_t SuffixArray::findPrevSmallerLCP(const size_t i, const size_t j, const size_t to, const size_t bound) const{
+    if (i >= to || getLCP(i, j) >= bound)
+        return 0;
+    if (j - i == 1)
+        return j;
+    size_t mid = (i + j) / 2;
+    size_t res = findPrevSmallerLCP(mid, j, to, bound);
+    if (res != 0)
+        return res;
+    return findPrevSmallerLCP(i, mid, to, bound);
+}
+
+// Widen [low, high] to all suffixes sharing the first length characters with SA[suffixArrayIndex]
+void SuffixArray::expandInterval(const size_t suffixArrayIndex, const size_t length, size_t &low, size_t &high) const{
+    low = findPrevSmallerLCP(0, SA.size() - 1, suffixArrayIndex, length);
+    size_t next = findNextSmallerLCP(0, SA.size() - 1, suffixArrayIndex, length);
+    high = (next == 0) ? SA.size() - 1 : next - 1;
+}
+
+// All suffixes in [low, high] share their first depth characters, so the characters
+// at offset depth are sorted and the ones equal to c form a subinterval
+bool SuffixArray::narrowInterval(const size_t depth, const size_t c, size_t &low, size_t &high) const{
+    // the sentinel is not part of the text and can not be matched
+    if (c == 0)
+        return false;
+
+    // first suffix whose character at depth is not smaller than c
+    size_t first = low, last = high + 1;
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        if (S[SA[mid] + depth] < c)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    if (first > high || S[SA[first] + depth] != c)
+        return false;
+    low = first;
+
+    // first suffix whose character at depth is bigger than c
+    last = high + 1;
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        if (S[SA[mid] + depth] <= c)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    high = first - 1;
+    return true;
+}
+
+// For every position of the query find the longest prefix of the remaining query occurring in the text.
+// The match is extended one character at a time by narrowing its SA interval and shortened
+// by one character through ISA, so the whole query takes O(m log n) instead of a search per offset
+std::vector<SuffixArray::ExactMatch> SuffixArray::matchingStatistics(const std::string &query) const{
+    std::vector<size_t> queryInt = convertString(query);
+    std::vector<ExactMatch> matches;
+    matches.reserve(queryInt.size());
+
+    size_t low = 0, high = SA.size() - 1, length = 0;
+    for (size_t i = 0; i < queryInt.size(); i++) {
+        while (i + length < queryInt.size() && narrowInterval(length, queryInt[i + length], low, high))
+            length++;
+
+        if (length == 0) {
+            matches.push_back({i, 0, 0, 0});
+            continue;
+        }
+        matches.push_back({i, length, low, high + 1});
+
+        // drop the first character, the suffix following SA[low] still matches the rest
+        length--;
+        if (length == 0) {
+            low = 0;
+            high = SA.size() - 1;
+        } else {
+            expandInterval(ISA[SA[low] + 1], length, low, high);
+        }
+    }
+    return matches;
+}
+
+// Super-maximal exact matches are the matches not contained in any other match of the query.
+// Match ends never decrease along the query, so a match is super-maximal exactly
+// when it ends further than the match starting one position earlier
+std::vector<SuffixArray::ExactMatch> SuffixArray::superMaximalExactMatches(const std::string &query, const size_t minLength) const{
+    std::vector<ExactMatch> stats = matchingStatistics(query);
+    std::vector<ExactMatch> matches;
+
+    for (size_t i = 0; i < stats.size(); i++) {
+        if (stats[i].length == 0 || stats[i].length < minLength)
+            continue;
+        if (i > 0 && stats[i - 1].length > stats[i].length)
+            continue;
+        matches.push_back(stats[i]);
+    }
+    return matches;
+}
+
+std::vector<size_t> SuffixArray::getOccurrences(const ExactMatch &match) const{
+    return std::vector<size_t>(SA.begin() + match.begin, SA.begin() + match.end);
+}
+
+// Builds a table of the SA bucket boundaries of every q-gram over the alphabet of the text.
+// Codes are dense over the characters present in the text, so the table holds sigma^q + 1 entries.
+// Since suffixes are sorted by their q-gram codes, the suffixes starting with any pattern of at most q characters
+// form a contiguous range of codes, and its interval is read from the table in O(1)
+void SuffixArray::buildQGramTable(const size_t q) {
+    qGramLength = 0;
+    qGramAlphabet.clear();
+    qGramTable.clear();
+    if (q == 0)
+        return;
+
+    // sentinel is left out of the alphabet, suffixes shorter than q get no q-gram
+    std::map<size_t, size_t> charCounts = calcCharCounts();
+    size_t nextCode = 0;
+    for (auto &pair : charCounts)
+        if (pair.first != 0)
+            qGramAlphabet[pair.first] = nextCode++;
+
+    size_t sigma = std::max<size_t>(qGramAlphabet.size(), 1);
+    size_t tableSize = 1;
+    for (size_t i = 0; i < q; i++) {
+        if (tableSize > MAX_QGRAM_TABLE_SIZE / sigma) {
+            qGramAlphabet.clear();
+            throw std::length_error("q-gram table for q = " + std::to_string(q) + " over " + std::to_string(sigma)
+                + " distinct characters exceeds " + std::to_string(MAX_QGRAM_TABLE_SIZE) + " entries, use a smaller q");
+        }
+        tableSize *= sigma;
+    }
+
+    // count the q-grams of all text positions with a rolling code, then turn the counts into bucket starts
+    size_t textLength = S.size() - 1;
+    qGramTable.assign(tableSize + 1, 0);
+    size_t code = 0;
+    for (size_t i = textLength; i-- > 0;) {
+        code = (code / sigma) + qGramAlphabet[S[i]] * (tableSize / sigma);
+        if (i + q <= textLength)
+            qGramTable[code + 1]++;
+    }
+    for (size_t i = 0; i < tableSize; i++)
+        qGramTable[i + 1] += qGramTable[i];
+    qGramLength = q;
+}
+
+// Interval [low, end) of the suffixes starting with the first min(q, m) characters of pattern.
+// The table only counts suffixes of length >= q, the at most q shorter ones are compared directly
+bool SuffixArray::getQGramInterval(const std::vector<size_t> &pattern, size_t &low, size_t &end) const{
+    size_t prefixLength = std::min(qGramLength, pattern.size());
+    size_t sigma = std::max<size_t>(qGramAlphabet.size(), 1);
+    size_t code = 0;
+    for (size_t i = 0; i < prefixLength; i++) {
+        auto it = qGramAlphabet.find(pattern[i]);
+        if (it == qGramAlphabet.end())
+            return false;
+        code = code * sigma + it->second;
+    }
+    size_t rangeSize = 1;
+    for (size_t i = prefixLength; i < qGramLength; i++)
+        rangeSize *= sigma;
+
+    low = qGramTable[code * rangeSize];
+    end = qGramTable[(code + 1) * rangeSize];
+
+    size_t textLength = S.size() - 1;
+    size_t shortStart = (textLength >= qGramLength) ? textLength - qGramLength + 1 : 0;
+    for (size_t position = shortStart; position <= textLength; position++) {
+        size_t matches = countMatches(pattern, 0, std::min(prefixLength, textLength - position), position);
+        if (matches == prefixLength) {
+            end++;
+        } else if (S[position + matches] < pattern[matches]) {
+            low++;
+            end++;
+        }
+    }
+    return low != end;
+}
+
+// Binary search restricted to [low, high], where every suffix already matches the first qGramLength characters.
+// The interval is not a node of the interval LCP tree, so only the min(lowMatches, highMatches) skip is used
+bool SuffixArray::searchInterval(const std::vector<size_t> &pattern, size_t &low, size_t &high) const{
+    size_t first = low, last = high + 1;
+    size_t lowMatches = qGramLength, highMatches = qGramLength;
+
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        size_t matches = countMatches(pattern, std::min(lowMatches, highMatches), pattern.size(), SA[mid]);
+
+        if (matches == pattern.size()) {
+            expandInterval(mid, pattern.size(), low, high);
+            return true;
+        } else if (S[SA[mid] + matches] < pattern[matches]) {
+            first = mid + 1;
+            lowMatches = matches;
+        } else {
+            last = mid;
+            highMatches = matches;
+        }
+    }
+    return false;
+}
+
+size_t SuffixArray::count(const std::string &pattern) const{
+    if (pattern.empty())
+        return 0;
+
+    size_t low, high;
+    if (!findInterval(convertString(pattern), low, high))
+        return 0;
+    return high - low + 1;
+}
+
+// Builds the child table with two stack passes over LCP, keeping up, down and nextl in one array of n entries:
+// up[i] is stored in childTable[i - 1], down[i] and nextl[i] in childTable[i].
+// up[i] is only defined when LCP[i - 1] > LCP[i], in which case neither down[i - 1] nor nextl[i - 1] is,
+// and down[i] is only needed when nextl[i] is undefined, so the fields never have to share an entry.
+// LCP[n] is taken as 0 so that every interval below the root is closed.
+// Index 0 is never an l-index, so 0 marks an undefined entry
+void SuffixArray::buildChildTable() {
+    size_t n = SA.size();
+    childTable.assign(n, 0);
+
+    std::vector<size_t> stack = {0};
+    size_t lastIndex = 0;
+    for (size_t i = 1; i <= n; i++) {
+        size_t curLCP = (i < n) ? LCP[i] : 0;
+        while (curLCP < LCP[stack.back()]) {
+            lastIndex = stack.back();
+            stack.pop_back();
+            if (curLCP <= LCP[stack.back()] && LCP[stack.back()] != LCP[lastIndex])
+                childTable[stack.back()] = lastIndex; // down
+        }
+        if (lastIndex != 0) {
+            childTable[i - 1] = lastIndex; // up
+            lastIndex = 0;
+        }
+        stack.push_back(i);
+    }
+
+    stack = {0};
+    for (size_t i = 1; i < n; i++) {
+        while (LCP[i] < LCP[stack.back()])
+            stack.pop_back();
+        if (LCP[i] == LCP[stack.back()]) {
+            childTable[stack.back()] = i; // nextl
+            stack.pop_back();
+        }
+        stack.push_back(i);
+    }
+}
+
+// First l-index of the lcp-interval [i, j], the LCP value there is the lcp of the interval
+size_t SuffixArray::getFirstLIndex(const size_t i, const size_t j) const{
+    // the sentinel suffix shares nothing with the rest, so the root always splits at 1
+    if (i == 0 && j == SA.size() - 1)
+        return 1;
+    // up[j + 1] is always defined for an lcp-interval, since LCP[j] >= lcp > LCP[j + 1]
+    size_t up = childTable[j];
+    if (i < up && up <= j)
+        return up;
+    return childTable[i]; // down
+}
+
+// Next l-index with the same LCP value as l-index i, or 0 if i is the last one of its interval
+size_t SuffixArray::getNextLIndex(const size_t i) const{
+    size_t next = childTable[i];
+    return (next > i && LCP[next] == LCP[i]) ? next : 0;
+}
+
+// Finds the child interval of [i, j] whose suffixes have character c at depth, the lcp of [i, j].
+// Children are visited in lexicographic order through the nextl chain, which is O(sigma)
+bool SuffixArray::getChildInterval(const size_t i, const size_t j, const size_t depth, const size_t c, size_t &low, size_t &high) const{
+    // the sentinel is not part of the text and can not be matched
+    if (c == 0)
+        return false;
+
+    size_t childLow = i;
+    size_t next = getFirstLIndex(i, j);
+    while (true) {
+        size_t childChar = S[SA[childLow] + depth];
+        if (childChar == c) {
+            low = childLow;
+            high = (next == 0) ? j : next - 1;
+            return true;
+        }
+        if (childChar > c || next == 0)
+            return false;
+        childLow = next;
+        next = getNextLIndex(childLow);
+    }
+}
+
+// Every suffix in [low, high] matches the first depth characters of pattern
+bool SuffixArray::searchChildTable(const std::vector<size_t> &pattern, size_t &low, size_t &high, size_t depth) const{
+    while (true) {
+        // a singleton interval extends to the end of its suffix, sentinel excluded
+        size_t intervalLCP = (low == high) ? S.size() - 1 - SA[low] : LCP[getFirstLIndex(low, high)];
+        size_t limit = std::min(intervalLCP, pattern.size());
+        if (countMatches(pattern, depth, limit, SA[low]) < limit)
+            return false;
+        if (limit == pattern.size())
+            return true;
+        if (low == high)
+            return false;
+
+        depth = intervalLCP;
+        if (!getChildInterval(low, high, depth, pattern[depth], low, high))
+            return false;
+        depth++;
+    }
+}
+
+// Bottom-up traversal of the lcp-intervals, each one with lcp >= minLength is a repeat
+// of its first lcp characters occurring end - begin times in the text
+std::vector<SuffixArray::LCPInterval> SuffixArray::findRepeats(const size_t minLength) const{
+    std::vector<LCPInterval> repeats;
+    std::vector<LCPInterval> stack = {{0, 0, 0}};
+    size_t n = SA.size();
+
+    for (size_t i = 1; i <= n; i++) {
+        size_t curLCP = (i < n) ? LCP[i] : 0;
+        size_t begin = i - 1;
+        while (curLCP < stack.back().lcp) {
+            LCPInterval interval = stack.back();
+            stack.pop_back();
+            interval.end = i;
+            begin = interval.begin;
+            if (interval.lcp >= minLength)
+                repeats.push_back(interval);
+        }
+        if (curLCP > stack.back().lcp)
+            stack.push_back({curLCP, begin, 0});
+    }
+    return repeats;
+}
+
+std::vector<size_t> SuffixArray::getOccurrences(const LCPInterval &interval) const{
+    return std::vector<size_t>(SA.begin() + interval.begin, SA.begin() + interval.end);
+}
+
+// Binary index format: magic, format version, the text as bytes, SA as raw size_t values,
+// the q-gram length and whether a child table was built.
+// LCP, ISA and the optional tables are rebuilt on load, which is linear and far cheaper than constructing SA.
+// An index is only portable between machines of the same word size and endianness
+namespace {
+    const char INDEX_MAGIC[4] = {'S', 'A', 'I', 'S'};
+    const size_t INDEX_VERSION = 2;
+    // bounded read size, so a corrupted length fails on the missing data instead of allocating it up front
+    const size_t READ_CHUNK_BYTES = size_t(1) << 23;
+
+    void writeValue(std::ostream &out, const size_t value) {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void writeVector(std::ostream &out, const std::vector<size_t> &values) {
+        writeValue(out, values.size());
+        out.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(size_t)));
+    }
+
+    size_t readValue(std::istream &in) {
+        size_t value;
+        if (!in.read(reinterpret_cast<char *>(&value), sizeof(value)))
+            throw std::runtime_error("truncated suffix array index");
+        return value;
+    }
+
+    std::string readString(std::istream &in) {
+        size_t size = readValue(in);
+        std::string string;
+        while (string.size() < size) {
+            size_t offset = string.size();
+            string.resize(offset + std::min(READ_CHUNK_BYTES, size - offset));
+            if (!in.read(&string[offset], static_cast<std::streamsize>(string.size() - offset)))
+                throw std::runtime_error("truncated suffix array index");
+        }
+        return string;
+    }
+
+    std::vector<size_t> readVector(std::istream &in) {
+        const size_t chunk = READ_CHUNK_BYTES / sizeof(size_t);
+        size_t size = readValue(in);
+        std::vector<size_t> values;
+        while (values.size() < size) {
+            size_t offset = values.size();
+            values.resize(offset + std::min(chunk, size - offset));
+            size_t bytes = (values.size() - offset) * sizeof(size_t);
+            if (!in.read(reinterpret_cast<char *>(values.data() + offset), static_cast<std::streamsize>(bytes)))
+                throw std::runtime_error("truncated suffix array index");
+        }
+        return values;
+    }
+}
+
+// Stores the text and its suffix array, the options of the optional tables are kept so that load rebuilds them
+void SuffixArray::save(std::ostream &out) const{
+    // only suffix arrays of strings can be stored, the recursive integer ones have no byte text
+    std::string text;
+    text.reserve(S.size());
+    for (size_t i = 0; i + 1 < S.size(); i++) {
+        char c = static_cast<char>(S[i]);
+        if (static_cast<size_t>(c - '\0') != S[i])
+            throw std::invalid_argument("only suffix arrays of strings can be saved");
+        text += c;
+    }
+
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    writeValue(out, INDEX_VERSION);
+    writeValue(out, text.size());
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    writeVector(out, SA);
+    writeValue(out, qGramLength);
+    writeValue(out, childTable.empty() ? 0 : 1);
+}
+
+// Checks that SA is the suffix array of S and rebuilds LCP and ISA from it.
+// A permutation keeps the rebuild in bounds, but the searches also rely on SA being sorted
+void SuffixArray::validate() {
+    const std::runtime_error corrupted("corrupted suffix array index");
+    size_t n = S.size();
+    if (n == 0 || S.back() != 0 || std::count(S.begin(), S.end(), 0) != 1 || SA.size() != n)
+        throw corrupted;
+
+    std::vector<bool> seen(n, false);
+    for (size_t suffix : SA) {
+        if (suffix >= n || seen[suffix])
+            throw corrupted;
+        seen[suffix] = true;
+    }
+
+    // neighbouring suffixes are in order when their first characters are,
+    // or when those are equal and the suffixes following them are, which ISA tells in O(1)
+    constructLCPArray();
+    if (SA[0] != n - 1)
+        throw corrupted;
+    for (size_t i = 1; i < n; i++) {
+        size_t a = SA[i - 1], b = SA[i];
+        if (S[a] > S[b] || (S[a] == S[b] && ISA[a + 1] > ISA[b + 1]))
+            throw corrupted;
+    }
+}
+
+SuffixArray SuffixArray::load(std::istream &in) {
+    char magic[sizeof(INDEX_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), INDEX_MAGIC))
+        throw std::runtime_error("not a suffix array index");
+    if (readValue(in) != INDEX_VERSION)
+        throw std::runtime_error("unsupported suffix array index version");
+
+    SuffixArray suffixArray;
+    suffixArray.constructS(readString(in));
+    suffixArray.SA = readVector(in);
+    size_t qGramLength = readValue(in);
+    size_t hasChildTable = readValue(in);
+    if (hasChildTable > 1)
+        throw std::runtime_error("corrupted suffix array index");
+
+    suffixArray.validate();
+    try {
+        suffixArray.buildQGramTable(qGramLength);
+    } catch (const std::length_error &) {
+        throw std::runtime_error("corrupted suffix array index");
+    }
+    if (hasChildTable)
+        suffixArray.buildChildTable();
+    return suffixArray;
+}
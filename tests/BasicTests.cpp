@@ -4,6 +4,9 @@
 #include <set>
 #include <algorithm>
 #include <cassert>
+#include <sstream>
+#include <random>
+#include <stdexcept>
 
 #include "../src/SuffixArray.h"
 
@@ -56,6 +59,11 @@ int main()
             "racecar",
             {7, 1, 5, 4, 2, 3, 6, 0},
             {{"race", {0}}, {"car", {4}}, {"ace", {1}}, {"a", {1, 5}}}
+        },
+        {
+            "AACACCAACCACCAACCACACAA",
+            {23, 22, 21, 0, 13, 6, 19, 17, 1, 10, 3, 14, 7, 20, 12, 5, 18, 16, 9, 2, 11, 4, 15, 8},
+            {{"ACC", {3, 7, 10, 14}}, {"CAA", {5, 12, 20}}, {"AACC", {6, 13}}}
         }
     };
 
@@ -95,5 +103,245 @@ int main()
         std::cout << "----------------------" << std::endl;
     }
 
+    std::cout << "Running random suffix array tests..." << std::endl;
+
+    // compares construction against sorting the suffixes directly, for both induction kernels
+    std::mt19937 generator(42);
+    for (size_t alphabetSize : {2, 4, 90}) {
+        for (size_t round = 0; round < 20; round++) {
+            std::string text;
+            size_t length = 1 + generator() % 2000;
+            for (size_t i = 0; i < length; i++)
+                text += static_cast<char>('!' + generator() % alphabetSize);
+
+            std::vector<size_t> expectedSuffixArray(text.size() + 1);
+            for (size_t i = 0; i < expectedSuffixArray.size(); i++)
+                expectedSuffixArray[i] = i;
+            std::sort(expectedSuffixArray.begin(), expectedSuffixArray.end(), [&text](size_t a, size_t b) {
+                return text.compare(a, std::string::npos, text, b, std::string::npos) < 0;
+            });
+
+            SuffixArray suffixArray(text);
+            assert(suffixArray.getSA() == expectedSuffixArray);
+        }
+    }
+    std::cout << "Test passed!" << std::endl;
+    std::cout << "----------------------" << std::endl;
+
+    std::cout << "Running q-gram table tests..." << std::endl;
+
+    for (const auto& dataSet : testData) {
+        std::cout << "Test String: " << dataSet.testString << std::endl;
+
+        for (size_t q = 1; q <= 3; q++) {
+            SuffixArray suffixArray(dataSet.testString);
+            suffixArray.buildQGramTable(q);
+
+            for (const auto& patternTest : dataSet.patternSearchTests) {
+                std::vector<size_t> actualResults = suffixArray.search(patternTest.first);
+                std::sort(actualResults.begin(), actualResults.end());
+                std::vector<size_t> expectedResults = patternTest.second;
+                std::sort(expectedResults.begin(), expectedResults.end());
+
+                assert(actualResults == expectedResults);
+                assert(suffixArray.count(patternTest.first) == expectedResults.size());
+            }
+            assert(suffixArray.search("#").empty());
+            assert(suffixArray.count("#" + dataSet.testString) == 0);
+            assert(suffixArray.count(dataSet.testString) == 1);
+        }
+
+        // a table that would not fit is refused instead of being allocated
+        if (dataSet.testString.size() > 1) {
+            SuffixArray suffixArray(dataSet.testString);
+            bool refused = false;
+            try {
+                suffixArray.buildQGramTable(64);
+            } catch (const std::length_error &) {
+                refused = true;
+            }
+            assert(refused || std::set<char>(dataSet.testString.begin(), dataSet.testString.end()).size() == 1);
+        }
+        std::cout << "Test passed!" << std::endl;
+        std::cout << "----------------------" << std::endl;
+    }
+
+    std::cout << "Running child table tests..." << std::endl;
+
+    for (const auto& dataSet : testData) {
+        std::cout << "Test String: " << dataSet.testString << std::endl;
+
+        for (size_t q = 0; q <= 2; q++) {
+            SuffixArray suffixArray(dataSet.testString);
+            suffixArray.buildChildTable();
+            suffixArray.buildQGramTable(q);
+
+            for (const auto& patternTest : dataSet.patternSearchTests) {
+                std::vector<size_t> actualResults = suffixArray.search(patternTest.first);
+                std::sort(actualResults.begin(), actualResults.end());
+                std::vector<size_t> expectedResults = patternTest.second;
+                std::sort(expectedResults.begin(), expectedResults.end());
+
+                assert(actualResults == expectedResults);
+            }
+            assert(suffixArray.search(dataSet.testString + dataSet.testString).empty());
+        }
+
+        // every repeat occurs at least twice and all its occurrences share the first lcp characters
+        SuffixArray suffixArray(dataSet.testString);
+        for (const auto& repeat : suffixArray.findRepeats(1)) {
+            std::vector<size_t> occurrences = suffixArray.getOccurrences(repeat);
+            assert(occurrences.size() >= 2);
+            std::string repeatString = dataSet.testString.substr(occurrences[0], repeat.lcp);
+            for (size_t occurrence : occurrences)
+                assert(dataSet.testString.compare(occurrence, repeat.lcp, repeatString) == 0);
+            assert(suffixArray.search(repeatString).size() == occurrences.size());
+        }
+        std::cout << "Test passed!" << std::endl;
+        std::cout << "----------------------" << std::endl;
+    }
+
+    std::cout << "Running save and load tests..." << std::endl;
+
+    for (const auto& dataSet : testData) {
+        std::cout << "Test String: " << dataSet.testString << std::endl;
+
+        SuffixArray original(dataSet.testString);
+        original.buildQGramTable(2);
+        original.buildChildTable();
+        std::stringstream stream;
+        original.save(stream);
+        SuffixArray suffixArray = SuffixArray::load(stream);
+
+        assert(suffixArray.getSA() == dataSet.expectedSuffixArray);
+        for (const auto& patternTest : dataSet.patternSearchTests) {
+            std::vector<size_t> actualResults = suffixArray.search(patternTest.first);
+            std::sort(actualResults.begin(), actualResults.end());
+            std::vector<size_t> expectedResults = patternTest.second;
+            std::sort(expectedResults.begin(), expectedResults.end());
+
+            assert(actualResults == expectedResults);
+            assert(suffixArray.count(patternTest.first) == expectedResults.size());
+        }
+        std::cout << "Test passed!" << std::endl;
+        std::cout << "----------------------" << std::endl;
+    }
+
+    {
+        // an index whose SA is a permutation but not sorted is refused,
+        // the searches would otherwise compare past the end of the text
+        const std::string text = "mmiissiissiippii";
+        SuffixArray original(text);
+        std::stringstream stream;
+        original.save(stream);
+        std::string index = stream.str();
+
+        // magic, version, text length and text, then the length of SA and its entries
+        size_t saOffset = 4 + 2 * sizeof(size_t) + text.size() + sizeof(size_t);
+        for (size_t swapped = 1; swapped + 1 <= text.size(); swapped += 5) {
+            std::string corrupted = index;
+            std::swap_ranges(corrupted.begin() + saOffset + swapped * sizeof(size_t),
+                             corrupted.begin() + saOffset + (swapped + 1) * sizeof(size_t),
+                             corrupted.begin() + saOffset + (swapped + 1) * sizeof(size_t));
+            std::stringstream corruptedStream(corrupted);
+            bool refused = false;
+            try {
+                SuffixArray::load(corruptedStream);
+            } catch (const std::runtime_error &e) {
+                refused = std::string(e.what()).find("corrupted") != std::string::npos;
+            }
+            assert(refused);
+        }
+    }
+    std::cout << "Test passed!" << std::endl;
+    std::cout << "----------------------" << std::endl;
+
+    std::cout << "Running edge case tests..." << std::endl;
+
+    {
+        SuffixArray emptyArray("");
+        assert(emptyArray.getSA() == std::vector<size_t>({0}));
+        assert(emptyArray.search("a").empty());
+        assert(emptyArray.count("a") == 0);
+
+        // the sentinel is not part of the text, patterns with NUL bytes never match
+        const std::string nulPatterns[] = {std::string(1, '\0'), std::string(5, '\0'), std::string("ss\0", 3), std::string("i\0s", 3)};
+        for (size_t q = 0; q <= 2; q++) {
+            SuffixArray suffixArray("mmiissiissiippii");
+            suffixArray.buildQGramTable(q);
+            for (bool childTable : {false, true}) {
+                if (childTable)
+                    suffixArray.buildChildTable();
+                for (const auto& pattern : nulPatterns) {
+                    assert(suffixArray.search(pattern).empty());
+                    assert(suffixArray.count(pattern) == 0);
+                }
+            }
+        }
+    }
+    std::cout << "Test passed!" << std::endl;
+    std::cout << "----------------------" << std::endl;
+
+    std::cout << "Running matching statistics tests..." << std::endl;
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> matchingData = {
+        {"mmiissiissiippii", {"missippi", "ississippi", "xmiissx", "p"}},
+        {"swiss_miss", {"swimming_miss", "misswiss", "zz"}},
+        {"abaabababbabbb", {"abababbbaab", "bbbbabaa"}},
+        {"aaaa", {"aaaaaa", "baab"}},
+        {"racecar", {"racecars", "acecarace"}}
+    };
+
+    for (const auto& dataSet : matchingData) {
+        const std::string& text = dataSet.first;
+        SuffixArray suffixArray(text);
+
+        for (const auto& query : dataSet.second) {
+            std::cout << "Matching " << query << " against " << text << std::endl;
+            std::vector<SuffixArray::ExactMatch> stats = suffixArray.matchingStatistics(query);
+            assert(stats.size() == query.size());
+
+            for (size_t i = 0; i < query.size(); i++) {
+                size_t expectedLength = 0;
+                while (i + expectedLength < query.size() && text.find(query.substr(i, expectedLength + 1)) != std::string::npos)
+                    expectedLength++;
+                assert(stats[i].length == expectedLength);
+
+                std::vector<size_t> actualResults = suffixArray.getOccurrences(stats[i]);
+                std::vector<size_t> expectedResults;
+                if (expectedLength > 0)
+                    expectedResults = suffixArray.search(query.substr(i, expectedLength));
+                std::sort(actualResults.begin(), actualResults.end());
+                std::sort(expectedResults.begin(), expectedResults.end());
+                assert(actualResults == expectedResults);
+            }
+
+            // super-maximal matches are the nonzero statistics not contained in any other one
+            for (size_t minLength = 1; minLength <= 3; minLength++) {
+                std::vector<size_t> expectedPositions;
+                for (const auto& match : stats) {
+                    if (match.length == 0 || match.length < minLength)
+                        continue;
+                    bool contained = false;
+                    for (const auto& other : stats)
+                        if (other.queryPos != match.queryPos && other.queryPos <= match.queryPos
+                            && other.queryPos + other.length >= match.queryPos + match.length)
+                            contained = true;
+                    if (!contained)
+                        expectedPositions.push_back(match.queryPos);
+                }
+
+                std::vector<size_t> actualPositions;
+                for (const auto& match : suffixArray.superMaximalExactMatches(query, minLength)) {
+                    assert(match.length == stats[match.queryPos].length);
+                    actualPositions.push_back(match.queryPos);
+                }
+                assert(actualPositions == expectedPositions);
+            }
+        }
+        std::cout << "Test passed!" << std::endl;
+        std::cout << "----------------------" << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -50,6 +50,20 @@ int main() {
         std::chrono::duration<double> elapsed_seconds = end - start;
         std::cout << "Suffix Array Creation time for " << stringFile << ": " << elapsed_seconds.count() << "s\n";
 
+        SuffixArray qGramSuffixArray(text);
+        start = std::chrono::high_resolution_clock::now();
+        qGramSuffixArray.buildQGramTable(10);
+        end = std::chrono::high_resolution_clock::now();
+        elapsed_seconds = end - start;
+        std::cout << "q-gram Table Creation time for " << stringFile << ": " << elapsed_seconds.count() << "s\n";
+
+        SuffixArray childTableSuffixArray(text);
+        start = std::chrono::high_resolution_clock::now();
+        childTableSuffixArray.buildChildTable();
+        end = std::chrono::high_resolution_clock::now();
+        elapsed_seconds = end - start;
+        std::cout << "Child Table Creation time for " << stringFile << ": " << elapsed_seconds.count() << "s\n";
+
         BruteForce bruteForce(text);
 
         for (const auto& patternFile : patternFiles) {
@@ -63,6 +77,24 @@ int main() {
             std::cout << "Suffix Array Search time for " << patternFile << ": " << elapsed_seconds.count() << "s\n";
             std::cout << "Found: " << found << " patterns." << std::endl;
 
+            found = 0;
+            start = std::chrono::high_resolution_clock::now();
+            for (const auto& pattern : patterns)
+                found += qGramSuffixArray.search(pattern).size();
+            end = std::chrono::high_resolution_clock::now();
+            elapsed_seconds = end - start;
+            std::cout << "Suffix Array (q-gram) Search time for " << patternFile << ": " << elapsed_seconds.count() << "s\n";
+            std::cout << "Found: " << found << " patterns." << std::endl;
+
+            found = 0;
+            start = std::chrono::high_resolution_clock::now();
+            for (const auto& pattern : patterns)
+                found += childTableSuffixArray.search(pattern).size();
+            end = std::chrono::high_resolution_clock::now();
+            elapsed_seconds = end - start;
+            std::cout << "Suffix Array (child table) Search time for " << patternFile << ": " << elapsed_seconds.count() << "s\n";
+            std::cout << "Found: " << found << " patterns." << std::endl;
+
             found = 0;
             start = std::chrono::high_resolution_clock::now();
             for (const auto& pattern : patterns)